@@ -71,6 +71,10 @@ _attribute_data_retention_ unsigned int  deepback_key_tick;
         #define KB_HAS_FN_KEY 1
     #endif
 
+    #ifndef KB_IDLE_LINE_DETECT_EN
+        #define KB_IDLE_LINE_DETECT_EN (!KB_LINE_MODE) //check idle drive lines instead of driving the matrix each scan
+    #endif
+
     #ifndef KB_DRV_DELAY_TIME
         #define KB_DRV_DELAY_TIME 10
     #endif
@@ -200,22 +204,38 @@ static unsigned char kb_is_fn_pressed = 0;
 
 kb_k_mp_t *kb_k_mp;
 
+_attribute_data_retention_ kb_event_time_t kb_event_time;
+
+/*
+ * Ghost keys: when a drive line holds two or more keys, a scan line shared with another drive line can not tell
+ * which keys are really pressed. The matrix rows are handled as bit slices of the transposed matrix, one pass
+ * over the drive lines counts per scan line whether it is pressed in one / two or more drive lines, and whether
+ * it is pressed in a drive line holding several keys. Scan lines with both are ghost lines, removed from every
+ * drive line.
+ */
 void kb_rmv_ghost_key(unsigned int *pressed_matrix)
 {
-    unsigned int mix_final = 0;
+    unsigned int col_once  = 0; //scan lines pressed in at least one drive line
+    unsigned int col_twice = 0; //scan lines pressed in at least two drive lines
+    unsigned int col_multi = 0; //scan lines pressed in a drive line holding more than one key
+
     foreach_arr(i, drive_pins)
     {
-        for (unsigned int j = (i + 1); j < ARRAY_SIZE(drive_pins); ++j) {
-            unsigned int mix = (pressed_matrix[i] & pressed_matrix[j]);
-            //four or three key at "#" is pressed at the same time, should remove ghost key
-            if (mix && (!BIT_IS_POW2(mix) || (pressed_matrix[i] ^ pressed_matrix[j]))) {
-                // remove ghost keys
-                //pressed_matrix[i] &= ~mix;
-                //pressed_matrix[j] &= ~mix;
-                mix_final |= mix;
-            }
+        unsigned int m = pressed_matrix[i];
+
+        col_twice |= col_once & m;
+        col_once |= m;
+        if (!BIT_IS_POW2(m)) {
+            col_multi |= m;
+        }
+    }
+
+    unsigned int ghost = col_twice & col_multi;
+    if (ghost) {
+        foreach_arr(i, drive_pins)
+        {
+            pressed_matrix[i] &= ~ghost;
         }
-        pressed_matrix[i] &= ~mix_final;
     }
 }
 
@@ -223,6 +243,8 @@ void kb_rmv_ghost_key(unsigned int *pressed_matrix)
 int key_matrix_same_as_last_cnt = 0; //record key matrix no change cnt
     #endif
 
+static unsigned int kb_raw_change_tick;
+
 unsigned int key_debounce_filter(unsigned int mtrx_cur[], unsigned int filt_en)
 {
     unsigned int kc = 0;
@@ -234,6 +256,9 @@ unsigned int key_debounce_filter(unsigned int mtrx_cur[], unsigned int filt_en)
     foreach_arr(i, drive_pins)
     {
         unsigned int mtrx_tmp = mtrx_cur[i];
+        if (mtrx_tmp != mtrx_pre[i]) { //first scan seeing the new level, debounced result follows in the next scan
+            kb_raw_change_tick = stimer_get_tick();
+        }
     #if (STUCK_KEY_PROCESS_ENABLE)
         stuckKeyPress[i] = mtrx_tmp ? 1 : 0;
     #endif
@@ -377,10 +402,46 @@ unsigned int kb_scan_row(int drv_ind, unsigned char *gpio)
 }
 
 unsigned int matrix_buff[4][ARRAY_SIZE(drive_pins)];
+unsigned int matrix_tick[4]; //kb_event_time.change_tick of each buffered matrix
 int          matrix_wptr, matrix_rptr;
 
+    #if (KB_IDLE_LINE_DETECT_EN)
+/**
+ * @brief       Check the drive lines of the idle matrix.
+ *              The drive lines are inputs pulled to the idle level, a pressed key pulls its drive line to the
+ *              level of the scan line pull, the same level that wakes up the chip from sleep. So a key press is
+ *              seen with one GPIO read, without driving the matrix and waiting for the lines to settle.
+ * @param[out]  gpio - GPIO level cache.
+ * @return      1: some key is pressed, 0: all keys released.
+ */
+static inline int kb_drive_line_active(unsigned char *gpio)
+{
+    gpio_read_all(gpio);
+    foreach_arr(i, drive_pins)
+    {
+        if (!!gpio_read_cache(drive_pins[i], gpio) != KB_LINE_HIGH_VALID) {
+            return 1;
+        }
+    }
+    return 0;
+}
+    #endif
+
 unsigned int kb_key_pressed(unsigned char *gpio)
 {
+    static unsigned char release_cnt = 0;
+    static unsigned int  ret_last    = 0;
+
+    #if (KB_IDLE_LINE_DETECT_EN)
+    //matrix idle, scan only when a key is held
+    if (!release_cnt) {
+        if (!kb_drive_line_active(gpio)) {
+            return 0;
+        }
+        kb_event_time.wakeup_tick = stimer_get_tick();
+    }
+    #endif
+
     foreach_arr(i, drive_pins)
     {
         if (KB_LINE_HIGH_VALID) {
@@ -393,9 +454,7 @@ unsigned int kb_key_pressed(unsigned char *gpio)
     sleep_us(20);
     gpio_read_all(gpio);
 
-    unsigned int         ret         = 0;
-    static unsigned char release_cnt = 0;
-    static unsigned int  ret_last    = 0;
+    unsigned int ret = 0;
 
     foreach_arr(i, scan_pins)
     {
@@ -457,6 +516,7 @@ unsigned int kb_scan_key_value(int numlock_status, int read_key, unsigned char *
         if (repeat_key.key_change_flg == KEY_SAME && repeat_key.key_repeat_flg &&
             clock_time_exceed(repeat_key.key_change_tick, (KB_REPEAT_KEY_INTERVAL_MS - 5) * 1000)) {
             repeat_key.key_change_tick = stimer_get_tick();
+            kb_raw_change_tick         = repeat_key.key_change_tick;
             key_changed                = 1;
         }
     }
@@ -469,7 +529,8 @@ unsigned int kb_scan_key_value(int numlock_status, int read_key, unsigned char *
     unsigned int *pd;
     if (key_changed) {
         /////////// push to matrix buffer /////////////////////////
-        pd = matrix_buff[matrix_wptr & 3];
+        matrix_tick[matrix_wptr & 3] = kb_raw_change_tick;
+        pd                           = matrix_buff[matrix_wptr & 3];
         for (unsigned int k = 0; k < ARRAY_SIZE(drive_pins); k++) {
             *pd++ = pressed_matrix[k];
         }
@@ -487,11 +548,13 @@ unsigned int kb_scan_key_value(int numlock_status, int read_key, unsigned char *
     if (matrix_wptr == matrix_rptr || !read_key) {
         return 0; //buffer empty, no data
     }
-    pd          = matrix_buff[matrix_rptr & 3];
-    matrix_rptr = (matrix_rptr + 1) & 7;
+    pd                        = matrix_buff[matrix_rptr & 3];
+    kb_event_time.change_tick = matrix_tick[matrix_rptr & 3];
+    matrix_rptr               = (matrix_rptr + 1) & 7;
 
     ///////////////////////////////////////////////////////////////////
     kb_remap_key_code(pd, KB_RETURN_KEY_MAX, &kb_event, numlock_status);
+    kb_event_time.report_tick = stimer_get_tick();
 
     #if (KB_REPEAT_KEY_ENABLE)
     if (repeat_key.key_change_flg == KEY_CHANGE) {
@@ -52,11 +52,20 @@ typedef struct
     unsigned int  key_change_tick;
 } repeatKey_t;
 
-extern repeatKey_t   repeat_key;
-extern kb_data_t     kb_event;
-extern kb_data_t     kb_event_cache;
-extern unsigned char deepback_key_state;
-extern unsigned int  deepback_key_tick;
+/* Key event timestamps in system timer tick, report_tick - change_tick is the scan-to-report latency. */
+typedef struct
+{
+    unsigned int wakeup_tick; //idle matrix left, key press seen on the drive lines
+    unsigned int change_tick; //first scan seeing the new matrix, before debounce
+    unsigned int report_tick; //matrix mapped into kb_event
+} kb_event_time_t;
+
+extern repeatKey_t     repeat_key;
+extern kb_event_time_t kb_event_time;
+extern kb_data_t       kb_event;
+extern kb_data_t       kb_event_cache;
+extern unsigned char   deepback_key_state;
+extern unsigned int    deepback_key_tick;
 
 
 #ifndef LONG_PRESS_KEY_POWER_OPTIMIZE
@@ -0,0 +1,95 @@
+/********************************************************************************************************
+ * @file    crc.h
+ *
+ * @brief   This is the header file for BLE SDK
+ *
+ * @author  BLE GROUP
+ * @date    2026
+ *
+ * @par     Copyright (c) 2026, Telink Semiconductor (Shanghai) Co., Ltd. ("TELINK")
+ *
+ *          Licensed under the Apache License, Version 2.0 (the "License");
+ *          you may not use this file except in compliance with the License.
+ *          You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *          Unless required by applicable law or agreed to in writing, software
+ *          distributed under the License is distributed on an "AS IS" BASIS,
+ *          WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *          See the License for the specific language governing permissions and
+ *          limitations under the License.
+ *
+ *******************************************************************************************************/
+#ifndef COMMON_CRC_H_
+#define COMMON_CRC_H_
+
+#include "types.h"
+
+/**
+ * @brief   CRC32 (IEEE 802.3, reflected polynomial 0xEDB88320) engine.
+ *          The update function does not apply the initial value nor the final XOR, so it can be
+ *          used for streaming: feed the running value back in chunk by chunk, the result is the same
+ *          as calculating the whole buffer at once.
+ *          It returns the same value as the bitwise and half-byte table implementations used before.
+ */
+#define CRC32_INIT_VALUE 0xFFFFFFFF
+#define CRC32_XOR_OUT    0xFFFFFFFF
+
+/**
+ * @brief   Number of slicing tables. 4: 4 KB table in flash, 8: 8 KB table in flash, about 1.6 times faster.
+ */
+#ifndef CRC32_SLICE_NUM
+    #define CRC32_SLICE_NUM 4
+#endif
+
+/**
+ * @brief   Buffers shorter than this are always calculated by software even if a hardware handler is
+ *          registered, the setup of the hardware is more expensive than the table for small chunks.
+ */
+#ifndef CRC32_HW_MIN_LEN
+    #define CRC32_HW_MIN_LEN 64
+#endif
+
+/**
+ * @brief   Hardware-assisted CRC32 handler, same semantics as crc32_update.
+ */
+typedef u32 (*crc32_hw_handler_t)(u32 crc, const u8 *data, u32 len);
+
+/**
+ * @brief       Register a hardware-assisted CRC32 handler for the chips that have one.
+ * @param[in]   handler - CRC32 handler, NULL to use the software tables only.
+ * @return      none.
+ */
+void crc32_register_hw_handler(crc32_hw_handler_t handler);
+
+/**
+ * @brief       Update a running CRC32 value with a data chunk (no initial value and no final XOR applied).
+ * @param[in]   crc  - running CRC value, start with CRC32_INIT_VALUE.
+ * @param[in]   data - data buffer, no alignment required.
+ * @param[in]   len  - data length.
+ * @return      updated CRC value.
+ */
+u32 crc32_update(u32 crc, const u8 *data, u32 len);
+
+/**
+ * @brief       Update a running CRC32 value by software only, the hardware handler is not used.
+ * @param[in]   crc  - running CRC value, start with CRC32_INIT_VALUE.
+ * @param[in]   data - data buffer, no alignment required.
+ * @param[in]   len  - data length.
+ * @return      updated CRC value.
+ */
+u32 crc32_update_sw(u32 crc, const u8 *data, u32 len);
+
+/**
+ * @brief       Calculate the standard CRC32 of a buffer (initial value and final XOR applied).
+ * @param[in]   data - data buffer.
+ * @param[in]   len  - data length.
+ * @return      CRC value.
+ */
+static inline u32 crc32_calc(const u8 *data, u32 len)
+{
+    return crc32_update(CRC32_INIT_VALUE, data, len) ^ CRC32_XOR_OUT;
+}
+
+#endif /* COMMON_CRC_H_ */
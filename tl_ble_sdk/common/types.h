@@ -69,7 +69,7 @@ typedef u16 wchar_t;
 #endif
 
 #ifndef WIN32
-typedef u32 size_t;
+typedef __SIZE_TYPE__ size_t; //u32 on the 32-bit targets, follows the host for host simulation build
 #endif
 
 #define U32_MAX ((u32)0xffffffff)
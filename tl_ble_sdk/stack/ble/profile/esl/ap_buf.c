@@ -27,12 +27,64 @@
 
 #include "esl_config.h"
 
+#define ESLP_AP_GROUP_ESLS 256 //ESL ID 0x00~0xFE, 0xFF is broadcast
+
 const u16 blc_eslp_apEslRecordsNum = ESLP_AP_ESL_RECORDS;
 const u8  blc_eslp_apGroupsNum     = ESLP_AP_MAX_GROUPS;
 
 static _attribute_ble_data_retention_ electronicShelfLabelRecord_t eslRecords[ESLP_AP_ESL_RECORDS];
 static accessPointPendingCommand_t                                 pendingCommands[ESLP_AP_MAX_GROUPS];
 static accessPointPendingResponses_t                               pendingResponses[ESLP_AP_MAX_GROUPS];
+static u32                                                         eslPresent[ESLP_AP_MAX_GROUPS][ESLP_AP_GROUP_ESLS / 32];
+
+#if (ESLP_AP_ESL_RECORDS < 0xFF)
+typedef u8 eslHotIdx_t;
+#else
+typedef u16 eslHotIdx_t;
+#endif
+/* hot record of each (group, ESL ID) plus 1, 0: none. A hint only, the stack picks the record slot itself */
+static eslHotIdx_t eslHotIndex[ESLP_AP_MAX_GROUPS][ESLP_AP_GROUP_ESLS];
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+    #if (ESLP_AP_ESL_RECORDS < MAX_RSP_SLOTS)
+        #error "ESLP_AP_ESL_RECORDS must hold the ESLs of a full PAwR payload when the cold tier is used"
+    #endif
+
+    #define ESL_COLD_SLOT_SIZE    32
+    #define ESL_COLD_SPARE_ADDR   (ESLP_AP_COLD_RECORDS_ADDR + ESLP_AP_MAX_GROUPS * ESLP_AP_COLD_GROUP_SIZE)
+
+    /* slot mark, flash bits only go from 1 to 0 without erase */
+    #define ESL_COLD_MARK_EMPTY   0xFF
+    #define ESL_COLD_MARK_VALID   0x5A
+    #define ESL_COLD_MARK_DELETED 0x00
+
+    /* spare sector state, it holds the new content of one sector from COMMITTED until that sector is rewritten */
+    #define ESL_COLD_SPARE_COPYING   0xFF
+    #define ESL_COLD_SPARE_COMMITTED 0x5A
+    #define ESL_COLD_SPARE_DONE      0x00
+
+typedef struct
+{
+    u8                     mark;
+    u8                     eslId;
+    u8                     groupId;
+    u8                     rsvd;
+    blc_esls_keyMaterial_t eslResponseKey;
+    u8                     rsvd1[4]; //in the spare sector, rsvd1 of slot 0 is the eslColdSpareTag_t
+} eslColdRecord_t;
+
+typedef struct
+{
+    u16 sector; //cold tier sector held by the spare, counted from ESLP_AP_COLD_RECORDS_ADDR
+    u8  rsvd;
+    u8  state;  //written after sector, so a COMMITTED state always has a complete tag
+} eslColdSpareTag_t;
+
+    #define ESL_COLD_SPARE_TAG_ADDR (ESL_COLD_SPARE_ADDR + ESL_COLD_SLOT_SIZE - sizeof(eslColdSpareTag_t))
+
+static u32 hotStamp[ESLP_AP_ESL_RECORDS];
+static u32 hotClock;
+#endif
 
 electronicShelfLabelRecord_t *blc_eslp_getEslRecord(u16 idx)
 {
@@ -48,3 +100,377 @@ accessPointPendingResponses_t *blc_eslp_getPendingResponse(u8 idx)
 {
     return idx >= ARRAY_SIZE(pendingResponses) ? NULL : &pendingResponses[idx];
 }
+
+u8 blc_eslp_rspSlotsUsed(accessPointPendingResponses_t *rsp)
+{
+    u32 slots = rsp->espectedResponseSlots & ESLP_RSP_SLOTS_MASK;
+    u8  n     = 0;
+
+    while (slots) {
+        slots &= slots - 1;
+        n++;
+    }
+
+    return n;
+}
+
+int blc_eslp_rspSlotFind(accessPointPendingResponses_t *rsp, u8 eslId)
+{
+    u32 slots = rsp->espectedResponseSlots & ESLP_RSP_SLOTS_MASK;
+
+    for (int i = 0; slots; i++, slots >>= 1) {
+        if ((slots & 1) && rsp->eslId[i] == eslId) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static bool eslAddressValid(blc_esls_eslAddress_t *eslAddress)
+{
+    return eslAddress->groupId < ESLP_AP_MAX_GROUPS && eslAddress->eslId != BLC_ESLS_ESL_ID_BROADCAST;
+}
+
+static bool eslPresentGet(blc_esls_eslAddress_t *eslAddress)
+{
+    return eslPresent[eslAddress->groupId][eslAddress->eslId >> 5] & BIT(eslAddress->eslId & 31);
+}
+
+static bool eslHotMatch(int idx, blc_esls_eslAddress_t *eslAddress)
+{
+    return eslRecords[idx].recordInUse &&
+           eslRecords[idx].eslAddress.eslId == eslAddress->eslId &&
+           eslRecords[idx].eslAddress.groupId == eslAddress->groupId;
+}
+
+static int eslHotFind(blc_esls_eslAddress_t *eslAddress)
+{
+    if (!eslAddressValid(eslAddress)) {
+        return -1;
+    }
+
+    eslHotIdx_t *pIdx = &eslHotIndex[eslAddress->groupId][eslAddress->eslId];
+
+    if (*pIdx && eslHotMatch(*pIdx - 1, eslAddress)) {
+        return *pIdx - 1;
+    }
+
+    /* not cached: not hot, or added by blc_eslp_ap_addEsl() directly */
+    for (int i = 0; i < ESLP_AP_ESL_RECORDS; i++) {
+        if (eslHotMatch(i, eslAddress)) {
+            *pIdx = i + 1;
+            return i;
+        }
+    }
+
+    *pIdx = 0;
+    return -1;
+}
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+static u32 eslColdAddr(u8 groupId, u8 eslId)
+{
+    return ESLP_AP_COLD_RECORDS_ADDR + groupId * ESLP_AP_COLD_GROUP_SIZE + eslId * ESL_COLD_SLOT_SIZE;
+}
+
+/* copy the valid slots of one sector to an erased sector, the spare tag is not copied */
+static void eslColdCopySector(u32 from, u32 to, u32 slotAddr, eslColdRecord_t *rec)
+{
+    eslColdRecord_t tmp;
+
+    for (u32 off = 0; off < 0x1000; off += ESL_COLD_SLOT_SIZE) {
+        if (from + off == slotAddr) {
+            tmp = *rec;
+        } else {
+            flash_read_page(from + off, ESL_COLD_SLOT_SIZE, (u8 *)&tmp);
+        }
+        if (tmp.mark == ESL_COLD_MARK_VALID) {
+            memset(tmp.rsvd1, 0xFF, sizeof(tmp.rsvd1));
+            flash_write_page(to + off, ESL_COLD_SLOT_SIZE, (u8 *)&tmp);
+        }
+    }
+}
+
+/* write the committed spare back to its sector, run again by init if the power was lost meanwhile */
+static void eslColdSpareRestore(u32 sector)
+{
+    u8 state = ESL_COLD_SPARE_DONE;
+
+    flash_erase_sector(sector);
+    eslColdCopySector(ESL_COLD_SPARE_ADDR, sector, 0, NULL);
+    flash_write_page(ESL_COLD_SPARE_TAG_ADDR + OFFSETOF(eslColdSpareTag_t, state), 1, &state);
+}
+
+/*
+ * rewrite the sector of one slot through the spare sector: deleted slots are dropped, the slot gets rec.
+ * The new content is complete in the spare before the sector is erased, so a power loss keeps either the old or
+ * the new content.
+ */
+static void eslColdRewrite(u32 slotAddr, eslColdRecord_t *rec)
+{
+    u32 sector = slotAddr & ~0xFFF;
+    u16 idx    = (sector - ESLP_AP_COLD_RECORDS_ADDR) >> 12;
+    u8  state  = ESL_COLD_SPARE_COMMITTED;
+
+    flash_erase_sector(ESL_COLD_SPARE_ADDR);
+    eslColdCopySector(sector, ESL_COLD_SPARE_ADDR, slotAddr, rec);
+    flash_write_page(ESL_COLD_SPARE_TAG_ADDR + OFFSETOF(eslColdSpareTag_t, sector), sizeof(idx), (u8 *)&idx);
+    flash_write_page(ESL_COLD_SPARE_TAG_ADDR + OFFSETOF(eslColdSpareTag_t, state), 1, &state);
+
+    eslColdSpareRestore(sector);
+}
+
+static void eslColdWrite(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *key)
+{
+    u32             addr = eslColdAddr(eslAddress->groupId, eslAddress->eslId);
+    eslColdRecord_t rec;
+
+    flash_read_page(addr, ESL_COLD_SLOT_SIZE, (u8 *)&rec);
+    if (rec.mark == ESL_COLD_MARK_VALID && !memcmp(&rec.eslResponseKey, key, sizeof(*key))) {
+        return;
+    }
+
+    bool erased = rec.mark == ESL_COLD_MARK_EMPTY;
+
+    memset(&rec, 0xFF, sizeof(rec));
+    rec.mark    = ESL_COLD_MARK_VALID;
+    rec.eslId   = eslAddress->eslId;
+    rec.groupId = eslAddress->groupId;
+    memcpy(&rec.eslResponseKey, key, sizeof(*key));
+
+    if (erased) {
+        flash_write_page(addr, ESL_COLD_SLOT_SIZE, (u8 *)&rec);
+    } else {
+        eslColdRewrite(addr, &rec);
+    }
+}
+
+static bool eslColdRead(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *key)
+{
+    eslColdRecord_t rec;
+
+    flash_read_page(eslColdAddr(eslAddress->groupId, eslAddress->eslId), ESL_COLD_SLOT_SIZE, (u8 *)&rec);
+    if (rec.mark != ESL_COLD_MARK_VALID) {
+        return false;
+    }
+
+    memcpy(key, &rec.eslResponseKey, sizeof(*key));
+    return true;
+}
+
+static void eslColdDelete(blc_esls_eslAddress_t *eslAddress)
+{
+    u32 addr = eslColdAddr(eslAddress->groupId, eslAddress->eslId);
+    u8  mark;
+
+    flash_read_page(addr, 1, &mark);
+    if (mark == ESL_COLD_MARK_VALID) {
+        mark = ESL_COLD_MARK_DELETED;
+        flash_write_page(addr, 1, &mark);
+    }
+}
+
+/* a record can leave the hot tier only when the stack does not wait for its response */
+static bool eslHotBusy(electronicShelfLabelRecord_t *rec)
+{
+    u8 groupId = rec->eslAddress.groupId;
+
+    if (groupId >= ESLP_AP_MAX_GROUPS) {
+        return false;
+    }
+
+    return pendingCommands[groupId].inProgress || blc_eslp_rspSlotFind(&pendingResponses[groupId], rec->eslAddress.eslId) >= 0;
+}
+
+static int eslHotEvict(void)
+{
+    int victim = -1;
+
+    for (int i = 0; i < ESLP_AP_ESL_RECORDS; i++) {
+        if (!eslRecords[i].recordInUse) {
+            return i;
+        }
+        if (!eslHotBusy(&eslRecords[i]) && (victim < 0 || (int)(hotStamp[i] - hotStamp[victim]) < 0)) {
+            victim = i;
+        }
+    }
+
+    if (victim >= 0) {
+        blc_esls_eslAddress_t eslAddress = eslRecords[victim].eslAddress;
+
+        if (eslAddressValid(&eslAddress)) {
+            eslColdWrite(&eslAddress, &eslRecords[victim].eslResponseKey);
+            eslPresent[eslAddress.groupId][eslAddress.eslId >> 5] |= BIT(eslAddress.eslId & 31);
+        }
+        blc_eslp_ap_removeEsl(&eslAddress);
+    }
+
+    return victim;
+}
+#endif
+
+void blc_eslp_apRecordsInit(void)
+{
+    memset(eslPresent, 0, sizeof(eslPresent));
+    memset(eslHotIndex, 0, sizeof(eslHotIndex));
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+    eslColdSpareTag_t tag;
+
+    flash_read_page(ESL_COLD_SPARE_TAG_ADDR, sizeof(tag), (u8 *)&tag);
+    if (tag.state == ESL_COLD_SPARE_COMMITTED && tag.sector < ESLP_AP_MAX_GROUPS * ESLP_AP_COLD_GROUP_SIZE / 0x1000) {
+        eslColdSpareRestore(ESLP_AP_COLD_RECORDS_ADDR + (tag.sector << 12)); //power lost while rewriting that sector
+    }
+
+    for (u8 groupId = 0; groupId < ESLP_AP_MAX_GROUPS; groupId++) {
+        for (int eslId = 0; eslId < BLC_ESLS_ESL_ID_BROADCAST; eslId++) {
+            u8 mark;
+
+            flash_read_page(eslColdAddr(groupId, eslId), 1, &mark);
+            if (mark == ESL_COLD_MARK_VALID) {
+                eslPresent[groupId][eslId >> 5] |= BIT(eslId & 31);
+            }
+        }
+    }
+#endif
+
+    for (int i = 0; i < ESLP_AP_ESL_RECORDS; i++) {
+        if (eslRecords[i].recordInUse && eslAddressValid(&eslRecords[i].eslAddress)) {
+            eslPresent[eslRecords[i].eslAddress.groupId][eslRecords[i].eslAddress.eslId >> 5] |= BIT(eslRecords[i].eslAddress.eslId & 31);
+        }
+    }
+}
+
+electronicShelfLabelRecord_t *blc_eslp_apFindRecord(blc_esls_eslAddress_t *eslAddress)
+{
+    int idx = eslHotFind(eslAddress);
+
+    return idx < 0 ? NULL : &eslRecords[idx];
+}
+
+ble_sts_t blc_eslp_apSaveRecord(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *eslResponseKey)
+{
+    if (!eslAddressValid(eslAddress)) {
+        return HCI_ERR_INVALID_HCI_CMD_PARAMS;
+    }
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+    int idx = eslHotFind(eslAddress);
+
+    /* a hot record with an old key would be written back over the new one when it is evicted */
+    if (idx >= 0 && memcmp(&eslRecords[idx].eslResponseKey, eslResponseKey, sizeof(*eslResponseKey))) {
+        if (eslHotBusy(&eslRecords[idx])) {
+            return HCI_ERR_CONTROLLER_BUSY;
+        }
+        blc_eslp_ap_removeEsl(eslAddress);
+    }
+
+    eslColdWrite(eslAddress, eslResponseKey);
+#else
+    (void)eslResponseKey;
+#endif
+    eslPresent[eslAddress->groupId][eslAddress->eslId >> 5] |= BIT(eslAddress->eslId & 31);
+
+    return BLE_SUCCESS;
+}
+
+ble_sts_t blc_eslp_apLoadRecord(blc_esls_eslAddress_t *eslAddress)
+{
+    int idx = eslHotFind(eslAddress);
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+    blc_esls_keyMaterial_t key;
+
+    if (idx < 0) {
+        if (!eslAddressValid(eslAddress) || !eslPresentGet(eslAddress) || !eslColdRead(eslAddress, &key)) {
+            return HCI_ERR_INVALID_HCI_CMD_PARAMS;
+        }
+        if (eslHotEvict() < 0) {
+            return HCI_ERR_LIMIT_REACHED;
+        }
+
+        ble_sts_t status = blc_eslp_ap_addEsl(eslAddress, &key);
+        if (status != BLE_SUCCESS) {
+            return status;
+        }
+
+        idx = eslHotFind(eslAddress);
+        if (idx < 0) {
+            return HCI_ERR_LIMIT_REACHED;
+        }
+    }
+
+    hotStamp[idx] = ++hotClock;
+#endif
+
+    return idx < 0 ? HCI_ERR_INVALID_HCI_CMD_PARAMS : BLE_SUCCESS;
+}
+
+ble_sts_t blc_eslp_apAddRecord(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *eslResponseKey)
+{
+#if (ESLP_AP_COLD_RECORDS_EN)
+    bool      known  = blc_eslp_apRecordExists(eslAddress);
+    ble_sts_t status = blc_eslp_apSaveRecord(eslAddress, eslResponseKey);
+
+    if (status == BLE_SUCCESS) {
+        status = blc_eslp_apLoadRecord(eslAddress);
+        if (status != BLE_SUCCESS && !known) {
+            blc_eslp_apDeleteRecord(eslAddress);
+        }
+    }
+#else
+    ble_sts_t status = blc_eslp_ap_addEsl(eslAddress, eslResponseKey);
+
+    if (status == BLE_SUCCESS) {
+        blc_eslp_apSaveRecord(eslAddress, eslResponseKey);
+    }
+#endif
+
+    return status;
+}
+
+void blc_eslp_apDeleteRecord(blc_esls_eslAddress_t *eslAddress)
+{
+    if (eslHotFind(eslAddress) >= 0) {
+        blc_eslp_ap_removeEsl(eslAddress);
+    }
+
+    if (!eslAddressValid(eslAddress)) {
+        return;
+    }
+
+#if (ESLP_AP_COLD_RECORDS_EN)
+    eslColdDelete(eslAddress);
+#endif
+    eslPresent[eslAddress->groupId][eslAddress->eslId >> 5] &= ~BIT(eslAddress->eslId & 31);
+}
+
+bool blc_eslp_apRecordExists(blc_esls_eslAddress_t *eslAddress)
+{
+    return (eslAddressValid(eslAddress) && eslPresentGet(eslAddress)) || eslHotFind(eslAddress) >= 0;
+}
+
+u16 blc_eslp_apGetRecordsNum(u8 groupId)
+{
+    u16 n = 0;
+
+    if (groupId >= ESLP_AP_MAX_GROUPS) {
+        return 0;
+    }
+
+    for (int i = 0; i < ESLP_AP_GROUP_ESLS / 32; i++) {
+        for (u32 bits = eslPresent[groupId][i]; bits; bits &= bits - 1) {
+            n++;
+        }
+    }
+
+    /* ESLs added to the stack without blc_eslp_apSaveRecord() */
+    for (int i = 0; i < ESLP_AP_ESL_RECORDS; i++) {
+        if (eslRecords[i].recordInUse && eslRecords[i].eslAddress.groupId == groupId && !eslPresentGet(&eslRecords[i].eslAddress)) {
+            n++;
+        }
+    }
+
+    return n;
+}
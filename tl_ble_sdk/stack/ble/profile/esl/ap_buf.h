@@ -25,6 +25,9 @@
 
 #define MAX_RSP_SLOTS 24
 
+/* response slots are tracked as a bitmap in a u32 */
+#define ESLP_RSP_SLOTS_MASK ((u32)((1ULL << MAX_RSP_SLOTS) - 1))
+
 typedef struct
 {
     bool                   recordInUse;
@@ -70,3 +73,93 @@ accessPointPendingCommand_t *blc_eslp_getPendingCommand(u8 idx);
  * @return          accessPointPendingResponses_t* - Pointer to the pending responses structure.
  */
 accessPointPendingResponses_t *blc_eslp_getPendingResponse(u8 idx);
+
+/**
+ * @brief           Number of response slots in use.
+ * @param[in]       rsp - Pending responses of a group.
+ * @return          u8 - Number of bits set in espectedResponseSlots.
+ */
+u8 blc_eslp_rspSlotsUsed(accessPointPendingResponses_t *rsp);
+
+/**
+ * @brief           Find the response slot expected from one ESL, only the slots in use are visited.
+ * @param[in]       rsp - Pending responses of a group.
+ * @param[in]       eslId - ESL ID.
+ * @return          int - Slot index, or -1 if no response is expected from the ESL.
+ */
+int blc_eslp_rspSlotFind(accessPointPendingResponses_t *rsp, u8 eslId);
+
+/**
+ * @brief           Initialize the ESL record store.
+ *                  The ESL records returned by blc_eslp_getEslRecord() are the hot tier in RAM.
+ *                  If ESLP_AP_COLD_RECORDS_EN is set, every ESL added with blc_eslp_apSaveRecord() also
+ *                  has its response key in a flash cold tier, packed per group, and is brought back
+ *                  into the hot tier on demand by blc_eslp_apLoadRecord(). The per-group presence
+ *                  bitmaps are rebuilt from flash here.
+ * @param[in]       none.
+ * @return          none.
+ */
+void blc_eslp_apRecordsInit(void);
+
+/**
+ * @brief           Find an ESL record in the hot tier.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @return          electronicShelfLabelRecord_t* - Pointer to the record, or NULL.
+ */
+electronicShelfLabelRecord_t *blc_eslp_apFindRecord(blc_esls_eslAddress_t *eslAddress);
+
+/**
+ * @brief           Keep the response key of an ESL in the cold tier.
+ *                  Without ESLP_AP_COLD_RECORDS_EN only the presence bitmap is updated.
+ *                  A hot record with another key is removed from the stack, blc_eslp_apLoadRecord()
+ *                  brings it back with the new key.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @param[in]       eslResponseKey - Pointer to the ESL response key material.
+ * @return          ble_sts_t - BLE_SUCCESS, HCI_ERR_INVALID_HCI_CMD_PARAMS for a bad address,
+ *                              or HCI_ERR_CONTROLLER_BUSY if the stack waits for a response with the old key.
+ */
+ble_sts_t blc_eslp_apSaveRecord(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *eslResponseKey);
+
+/**
+ * @brief           Add an ESL to the record store and to the stack.
+ *                  If ESLP_AP_COLD_RECORDS_EN is set, the key goes to the cold tier and the record is
+ *                  loaded with blc_eslp_apLoadRecord(), so a full hot tier evicts a record instead of
+ *                  failing. An ESL that was not known before is removed again if it cannot be loaded.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @param[in]       eslResponseKey - Pointer to the ESL response key material.
+ * @return          ble_sts_t - BLE_SUCCESS, or the error of blc_eslp_apSaveRecord(),
+ *                              blc_eslp_apLoadRecord() or blc_eslp_ap_addEsl().
+ */
+ble_sts_t blc_eslp_apAddRecord(blc_esls_eslAddress_t *eslAddress, blc_esls_keyMaterial_t *eslResponseKey);
+
+/**
+ * @brief           Make sure an ESL record is in the hot tier, so that commands can be sent to it.
+ *                  When the hot tier is full, the least recently loaded record with no pending
+ *                  response is written back to the cold tier and removed from the stack.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @return          ble_sts_t - BLE_SUCCESS,
+ *                              HCI_ERR_INVALID_HCI_CMD_PARAMS if the ESL is unknown,
+ *                              HCI_ERR_LIMIT_REACHED if no hot record can be evicted.
+ */
+ble_sts_t blc_eslp_apLoadRecord(blc_esls_eslAddress_t *eslAddress);
+
+/**
+ * @brief           Remove an ESL from both tiers and from the stack.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @return          none.
+ */
+void blc_eslp_apDeleteRecord(blc_esls_eslAddress_t *eslAddress);
+
+/**
+ * @brief           Check if an ESL is known in any tier.
+ * @param[in]       eslAddress - Pointer to the ESL address.
+ * @return          bool - true if known.
+ */
+bool blc_eslp_apRecordExists(blc_esls_eslAddress_t *eslAddress);
+
+/**
+ * @brief           Number of ESLs known in one group.
+ * @param[in]       groupId - Group ID.
+ * @return          u16 - Number of ESLs.
+ */
+u16 blc_eslp_apGetRecordsNum(u8 groupId);
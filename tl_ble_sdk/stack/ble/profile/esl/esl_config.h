@@ -32,3 +32,15 @@
 #ifndef ESLP_AP_MAX_GROUPS
 #define ESLP_AP_MAX_GROUPS 8
 #endif
+
+/* ESL records in RAM (ESLP_AP_ESL_RECORDS) are the hot tier, ESLs beyond it can be kept in a flash cold tier */
+#ifndef ESLP_AP_COLD_RECORDS_EN
+#define ESLP_AP_COLD_RECORDS_EN 0
+#endif
+
+#define ESLP_AP_COLD_GROUP_SIZE   0x2000 //256 slots of 32 bytes, indexed by ESL ID
+#define ESLP_AP_COLD_RECORDS_SIZE (ESLP_AP_MAX_GROUPS * ESLP_AP_COLD_GROUP_SIZE + 0x1000) //plus one spare sector
+
+#if (ESLP_AP_COLD_RECORDS_EN && !defined(ESLP_AP_COLD_RECORDS_ADDR))
+#error "ESLP_AP_COLD_RECORDS_ADDR must be set to a 4K aligned flash area of ESLP_AP_COLD_RECORDS_SIZE bytes"
+#endif
@@ -44,6 +44,7 @@
 #include "vendor/common/blt_fw_sign.h"
 #include "vendor/common/blt_led.h"
 #include "vendor/common/blt_soft_timer.h"
+#include "vendor/common/blt_flash_job.h"
 #include "vendor/common/device_manage.h"
 #include "vendor/common/simple_sdp.h"
 #include "vendor/common/flash_fw_check.h"